@@ -65,6 +65,21 @@ function SampleToTime(Sample,SamplingFreq)
     return Sample/SamplingFreq 
 end
 
+--[[
+**
+* Function:     newSampleObj
+* Arguments:    source              -playdate.sound.sample, or the path of a 16 bit mono .wav file
+*
+* Returns:      SampleObj           -samplelib.samples object (must be freed with samplelib.samples.free)
+* Description:  Wraps a sample that is in memory, or streams the file in small chunks so long recordings don't need to fit in the heap
+**]]
+function newSampleObj(source)
+    if type(source) == "string" then
+        return samplelib.samples.newFromFile(source,0)
+    end
+    return samplelib.samples.new(source)
+end
+
 --[[
 **
 * Function:     encodeByte
@@ -102,6 +117,38 @@ function encodeByte(SampleObj,FreqArray,BitArray,Amp,StartSample,EndSample)
 
 end
 
+--[[
+**
+* Function:     decodeBits
+* Arguments:    FFTObj              -fftlib.fft object already in the frequency domain (after runFFT)
+*               FreqArray           -Array containing the frequencies used to encode each bit
+*               threshold           -Minimum amplitude needed for a bit to be considered a 1
+*               SampleFreq          -Number of samples recorded per second
+*               SampleSize          -Length of the FFT (after padding)
+*
+* Returns:      BitArray            -Array containing the decoded bits
+* Description:  Compares the magnitudes of the two frequencies of each bit in an FFT that was already run (shared by decodeByte and decodeChannels)
+**]]
+function decodeBits(FFTObj,FreqArray,threshold,SampleFreq,SampleSize)
+    local BitArray = {}
+
+    --Decoding bit in each frequency pair
+    for i =1,#FreqArray do
+        local mag0 = fftlib.fft.getAbsFreq(FFTObj,FreqToIdx(FreqArray[i][1],SampleFreq,SampleSize))  --Get the magnitude for bit = 0
+        local mag1 = fftlib.fft.getAbsFreq(FFTObj,FreqToIdx(FreqArray[i][2],SampleFreq,SampleSize))  --Get the magnitude for bit = 1
+
+        if mag1 - mag0 > threshold then
+            BitArray[i] = 1
+        elseif mag0 - mag1 > threshold then
+            BitArray[i] = 0 
+        else
+            BitArray[i] = -math.abs( mag0 - mag1 )
+        end
+    end
+
+    return BitArray
+end
+
 --[[
 **
 * Function:     decodeByte
@@ -115,38 +162,90 @@ end
 * Description:  Decodes the bits in SampleObj on the frequencies of FreqArray between StartSample and EndSample
 **]]
 function decodeByte(SampleObj,FreqArray,threshold,StartSample,EndSample)
-    local mag
     local SampleFreq = 44100
 
-    local BitArray = {}
-
     --Initialize FFT
     local FFTObj = fftlib.fft.new(SampleObj,StartSample,EndSample)
     fftlib.fft.runFFT(FFTObj)
     local SampleSize = fftlib.fft.getLength(FFTObj)
 
-    --Decoding bit in each frequency pair
-    for i =1,#FreqArray do
-        mag0 = fftlib.fft.getAbsFreq(FFTObj,FreqToIdx(FreqArray[i][1],SampleFreq,SampleSize))  --Get the magnitude for bit = 0
-        mag1 = fftlib.fft.getAbsFreq(FFTObj,FreqToIdx(FreqArray[i][2],SampleFreq,SampleSize))  --Get the magnitude for bit = 1
+    local BitArray = decodeBits(FFTObj,FreqArray,threshold,SampleFreq,SampleSize)
+    fftlib.fft.free(FFTObj)
 
-        if mag1 - mag0 > threshold then
-            BitArray[i] = 1
-        elseif mag0 - mag1 > threshold then
-            BitArray[i] = 0 
-        else
-            BitArray[i] = -math.abs( mag0 - mag1 )
+    return BitArray
+end
+
+--[[
+**
+* Function:     makeChannelFreqArrays
+* Arguments:    numChannels         -Number of channels (transmitters that can send at the same time)
+*               SampleSize          -Number of samples used in each FFT by the receiver (power of 2, e.g. 256 for 3 channels, 512 for 7)
+*               SamplingFreq        -Number of samples recorded per second
+*
+* Returns:      ChannelFreqArrays   -Array with one FreqArray (8 bits) per channel, or nil if they don't fit
+* Description:  Splits 344Hz to 20kHz in numChannels non-overlapping sets of tones. Each tone is the center of a bin of
+*               the SampleSize FFT and the tones are at least 2 bins apart, where the hamming window barely leaks
+**]]
+function makeChannelFreqArrays(numChannels,SampleSize,SamplingFreq)
+    local NumBits = 8
+    local FirstBin = FreqToIdx(344.53125,SamplingFreq,SampleSize)
+    local LastBin = math.floor(20000*(SampleSize/SamplingFreq))
+    local NumTones = numChannels*NumBits*2
+    local Spacing = math.floor((LastBin-FirstBin)/(NumTones-1))
+
+    if Spacing < 2 then
+        print("Error in function makeChannelFreqArrays: ",numChannels," channels don't fit in a ",SampleSize," sample FFT, use a bigger SampleSize")
+        return nil
+    end
+
+    --Each channel gets its own band, with the 2 frequencies of each bit next to each other
+    local ChannelFreqArrays = {}
+    local Bin = FirstBin
+    for c = 1,numChannels do
+        ChannelFreqArrays[c] = {}
+        for i = 1,NumBits do
+            ChannelFreqArrays[c][i] = {IdxToFreq(Bin,SamplingFreq,SampleSize),IdxToFreq(Bin+Spacing,SamplingFreq,SampleSize)}
+            Bin = Bin + 2*Spacing
         end
     end
+
+    return ChannelFreqArrays
+end
+
+--[[
+**
+* Function:     decodeChannels
+* Arguments:    SampleObj           -Sample object from samplelib.samples to search the data
+*               ChannelFreqArrays   -Array of FreqArrays, one per channel (see makeChannelFreqArrays)
+*               threshold           -Minimum amplitude needed for a bit to be considered a 1
+*               StartSample         -Sample to start the FFT
+*               EndSample           -Sample to end the FFT (EndSample-StartSample should be the SampleSize used for the channels)
+*
+* Returns:      BitArrays           -Array with the decoded BitArray of each channel
+* Description:  Decodes every channel from a single FFT, so listening to more channels only costs a few more magnitude lookups
+**]]
+function decodeChannels(SampleObj,ChannelFreqArrays,threshold,StartSample,EndSample)
+    local SampleFreq = 44100
+
+    local BitArrays = {}
+
+    --One FFT for all the channels
+    local FFTObj = fftlib.fft.new(SampleObj,StartSample,EndSample)
+    fftlib.fft.runFFT(FFTObj)
+    local SampleSize = fftlib.fft.getLength(FFTObj)
+
+    for c = 1,#ChannelFreqArrays do
+        BitArrays[c] = decodeBits(FFTObj,ChannelFreqArrays[c],threshold,SampleFreq,SampleSize)
+    end
     fftlib.fft.free(FFTObj)
 
-    return BitArray
+    return BitArrays
 end
 
 --[[
 **
 * Function:     Sync
-* Arguments:    sample              -playdate.sound.sample that contains the string
+* Arguments:    sample              -playdate.sound.sample (or path of a .wav file) that contains the string
 *               threshold           -Minimum amplitude needed for a bit to be considered a 1
 *               FreqArray           -Array containing the frequencies used to encode each bit
 *               samplePerChar       -Number of Samples to encode 1 character
@@ -157,7 +256,7 @@ end
 **]]
 function Sync(sample,threshold,FreqArray,samplePerChar)
 
-    local SampleObj = samplelib.samples.new(sample)
+    local SampleObj = newSampleObj(sample)
     local length = samplelib.samples.getLength(SampleObj)
     if length<0 then
         print("Error in Sync function: Could not read length from SampleObj")
@@ -70,7 +70,7 @@ end
 --[[
 **
 * Function:     decodeString
-* Arguments:    sample              -playdate.sound.sample that contains the string
+* Arguments:    sample              -playdate.sound.sample (or path of a .wav file) that contains the string
 *               StartSample         -Sample where the string starts (use Sync function to find this)
 *               threshold           -Minimum amplitude needed for a bit to be considered a 1
 *               FreqArray           -Array containing the Frequencies used for encoding (for char the minimum size is 8)
@@ -81,17 +81,60 @@ end
 **]]
 function decodeString(sample,threshold,FreqArray,PrevStr)
 
-    local SampleObj = samplelib.samples.new(sample)
+    local SampleObj = newSampleObj(sample)
     local length = samplelib.samples.getLength(SampleObj)
     local SampleFreq = 44100
 
     local BitArray = {}
-    local AsciiInt = 0
 
     --Decoding char in msg
     --Decode 1 byte
     BitArray = decodeByte(SampleObj,FreqArray,threshold,0,128)
     samplelib.samples.free(SampleObj)
+
+    return appendByte(BitArray,PrevStr)
+end
+
+--[[
+**
+* Function:     decodeStringChannels
+* Arguments:    sample              -playdate.sound.sample (or path of a .wav file) that contains the strings
+*               threshold           -Minimum amplitude needed for a bit to be considered a 1
+*               ChannelFreqArrays   -Array of FreqArrays, one per channel (see makeChannelFreqArrays)
+*               PrevStrs            -Array with the string received so far on each channel
+*               SampleSize          -Number of samples in the FFT (the one used in makeChannelFreqArrays)
+*
+* Returns:      strs                -Array with the string of each channel (with the new character appended, if there was one)
+* Description:  Same as decodeString, but for every channel at once using a single FFT
+**]]
+function decodeStringChannels(sample,threshold,ChannelFreqArrays,PrevStrs,SampleSize)
+
+    local SampleObj = newSampleObj(sample)
+
+    --Decode 1 byte of every channel
+    local BitArrays = decodeChannels(SampleObj,ChannelFreqArrays,threshold,0,SampleSize)
+    samplelib.samples.free(SampleObj)
+
+    local strs = {}
+    for c=1,#ChannelFreqArrays do
+        strs[c] = appendByte(BitArrays[c],PrevStrs[c] or "")
+    end
+
+    return strs
+end
+
+--[[
+**
+* Function:     appendByte
+* Arguments:    BitArray            -Array of decoded bits (from decodeByte or decodeChannels)
+*               PrevStr             -String received so far
+*
+* Returns:      str                 -PrevStr with the decoded character appended, or PrevStr if a bit was unclear or the byte was "\0"
+* Description:  Converts a BitArray in to a character and appends it to the string
+**]]
+function appendByte(BitArray,PrevStr)
+    local AsciiInt = 0
+
     --BitArray to String
     for j=1,#BitArray do
         AsciiInt<<=1
@@ -108,7 +151,7 @@ function decodeString(sample,threshold,FreqArray,PrevStr)
         return PrevStr
     end
     
-    str = PrevStr..string.char(AsciiInt)
+    local str = PrevStr..string.char(AsciiInt)
     --TODO: Error correction code here
 
     return str
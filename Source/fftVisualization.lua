@@ -10,7 +10,7 @@ local gfx <const> = pd.graphics
 --[[
 **
 * Function:     FFTAbsGraph
-* Arguments:    sample                  -playdate.sound.sample that we want to analyse
+* Arguments:    sample                  -playdate.sound.sample (or path of a .wav file) that we want to analyse
 *               x                       -The top left corner x coordenate 
 *               y                       -The top left corner y coordenate 
 *               w                       -The width of the graph
@@ -25,7 +25,7 @@ local gfx <const> = pd.graphics
 function FFTAbsGraph(sample,x,y,w,h,startSample,StartFreq,EndFreq)
     gfx.clear()
     --Get samples
-    local SampleObj = samplelib.samples.new(sample)
+    local SampleObj = newSampleObj(sample)
     local length = samplelib.samples.getLength(SampleObj)
 
 
@@ -64,7 +64,7 @@ end
 --[[
 **
 * Function:     spectrogram
-* Arguments:    sample                  -playdate.sound.sample that we want to analyse
+* Arguments:    sample                  -playdate.sound.sample (or path of a .wav file) that we want to analyse
 *               x                       -The top left corner x coordenate 
 *               y                       -The top left corner y coordenate 
 *               w                       -The width of the graph
@@ -82,7 +82,7 @@ end
 function spectrogram(sample,x,y,w,h,threshold,sampleSize,StartFreq,EndFreq,StartTime,EndTime)
     gfx.clear()
     --Get Samples
-    local SampleObj = samplelib.samples.new(sample)
+    local SampleObj = newSampleObj(sample)
 
     -- Get frequency limits
     local StartIdx = 0                                         --default
@@ -136,7 +136,7 @@ end
 --[[
 **
 * Function:     VisualizeSamples
-* Arguments:    sample                  -playdate.sound.sample that we want to analyse
+* Arguments:    sample                  -playdate.sound.sample (or path of a .wav file) that we want to analyse
 *               x                       -The top left corner x coordenate 
 *               y                       -The top left corner y coordenate 
 *               w                       -The width of the graph
@@ -154,7 +154,7 @@ function VisualizeSamples(sample,x,y,w,h,MaxPressure,StartIdx,EndIdx)
 
     gfx.clear()
     --Get Samples
-    local SampleObj = samplelib.samples.new(sample)
+    local SampleObj = newSampleObj(sample)
     local length = EndIdx-StartIdx      --Calculate the amount of samples to draw
 
     local lastAmp=0
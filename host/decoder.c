@@ -0,0 +1,247 @@
+#include <string.h>
+#include "decoder.h"
+
+//Reference decoder for dosdecode: the per-byte decision is the app's (decodeBits), the sync and framing are not
+
+/**
+* Function:     decoderDefaultConfig
+* Arguments:    cfg                 -decoderConfig to fill in
+*               
+* Returns:
+* Description:  Uses the same FreqArray, samplePerChar and threshold as Source/main.lua
+**/
+void decoderDefaultConfig(decoderConfig *cfg){
+    const float baseFreq = 344.53125f;
+
+    //{baseFreq,4*baseFreq},{7*baseFreq,10*baseFreq},...,{43*baseFreq,46*baseFreq}
+    for(int i=0;i<DECODER_BITS;i++){
+        cfg->FreqArray[i][0] = (6*i + 1) * baseFreq;
+        cfg->FreqArray[i][1] = (6*i + 4) * baseFreq;
+    }
+    cfg->threshold = 10;
+    cfg->samplePerChar = 3675;
+    cfg->windowSize = 128;
+    cfg->syncStep = 64;
+}
+
+/**
+* Function:     decoderScratchInit
+* Arguments:    scratch             -decoderScratch to allocate
+*               windowSize          -FFT size
+*               
+* Returns:      0 on success, -1 if out of memory
+* Description:  Allocates the per-thread FFT buffers
+**/
+int decoderScratchInit(decoderScratch *scratch, uint32_t windowSize){
+    scratch->re = malloc(sizeof(int32_t) * windowSize);
+    scratch->im = malloc(sizeof(int32_t) * windowSize);
+    if(scratch->re == NULL || scratch->im == NULL){
+        decoderScratchFree(scratch);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+* Function:     decoderScratchFree
+* Arguments:    scratch             -decoderScratch to free
+*               
+* Returns:
+* Description:  Frees memory
+**/
+void decoderScratchFree(decoderScratch *scratch){
+    free(scratch->re);
+    free(scratch->im);
+    scratch->re = NULL;
+    scratch->im = NULL;
+}
+
+//Same rounding as FreqToIdx in Source/fftFunctions.lua
+static int freqToIdx(float freq, uint32_t SFreq, uint32_t n){
+    return (int)floorf(freq * ((float)n / (float)SFreq) + 0.5f);
+}
+
+/**
+* Function:     decodeWindow
+* Arguments:    cfg                 -decoderConfig with the frequencies and threshold
+*               scratch             -This thread's FFT buffers
+*               s                   -Samples to decode
+*               bins                -FFT bins of cfg->FreqArray
+*               start               -First sample of the window
+*               byte                -Decoded byte
+*               margin              -Smallest magnitude difference between the two frequencies of a bit (can be NULL)
+*               
+* Returns:      Number of ambiguous bits (0 means byte is valid)
+* Description:  Runs the same functions as runFFT (hamming window + FFT), scales the magnitudes like getAbsFreq, then compares
+*               the magnitude of both frequencies of each bit with the same rule as decodeBits in Source/fftFunctions.lua
+**/
+static int decodeWindow(const decoderConfig *cfg, decoderScratch *scratch, const Samples *s, int bins[DECODER_BITS][2], uint32_t start, int *byte, float *margin){
+    uint32_t n = cfg->windowSize;
+
+    for(uint32_t i=0;i<n;i++){
+        scratch->re[i] = (start + i < s->length) ? s->data[start + i] : 0;
+        scratch->im[i] = 0;
+    }
+    apply_hamming_window(scratch->re, (int)n);
+    fft_fixed_iterative(scratch->re, scratch->im, n);
+
+    int ambiguous = 0;
+    float minDiff = -1;
+    *byte = 0;
+    for(int i=0;i<DECODER_BITS;i++){
+        int b0 = bins[i][0], b1 = bins[i][1];
+        float mag0 = sqrtf((float)scratch->re[b0]*scratch->re[b0] + (float)scratch->im[b0]*scratch->im[b0]) * fft_bin_scale(b0, n);
+        float mag1 = sqrtf((float)scratch->re[b1]*scratch->re[b1] + (float)scratch->im[b1]*scratch->im[b1]) * fft_bin_scale(b1, n);
+
+        float diff = fabsf(mag1 - mag0);
+        if(minDiff < 0 || diff < minDiff){
+            minDiff = diff;
+        }
+
+        *byte <<= 1;
+        if(mag1 - mag0 > cfg->threshold){
+            *byte += 1;
+        }else if(mag0 - mag1 <= cfg->threshold){
+            ambiguous++;
+        }
+    }
+    if(margin != NULL){
+        *margin = minDiff;
+    }
+
+    return ambiguous;
+}
+
+/**
+* Function:     strongestWindow
+* Arguments:    cfg                 -decoderConfig with the frequencies and threshold
+*               scratch             -This thread's FFT buffers
+*               s                   -Samples to decode
+*               bins                -FFT bins of cfg->FreqArray
+*               from                -First window to try
+*               to                  -Windows start before this sample
+*               
+* Returns:      Start of the window with the largest margin (see decodeWindow) that decodes a valid byte, from if there is none
+* Description:  The characters are sent with a hamming envelope, so the margin is the largest in the middle of a character
+**/
+static uint32_t strongestWindow(const decoderConfig *cfg, decoderScratch *scratch, const Samples *s, int bins[DECODER_BITS][2], uint32_t from, uint32_t to){
+    uint32_t best = from;
+    float bestMargin = -1;
+    int byte = 0;
+    float margin = 0;
+
+    for(uint32_t pos = from; pos < to && pos + cfg->windowSize <= s->length; pos += cfg->syncStep){
+        if(decodeWindow(cfg, scratch, s, bins, pos, &byte, &margin) == 0 && margin > bestMargin){
+            bestMargin = margin;
+            best = pos;
+        }
+    }
+
+    return best;
+}
+
+/**
+* Function:     decodeSamples
+* Arguments:    cfg                 -decoderConfig (shared, read-only)
+*               scratch             -This thread's FFT buffers
+*               s                   -Samples of one recording
+*               res                 -decodeResult to fill in (ms is left to the caller)
+*               
+* Returns:
+* Description:  Reference decoder for whole recordings. The sync and the message framing are this tool's own, the app
+*               decodes one byte per call with decodeString and finds the message with Sync instead.
+*               Finds the first character, then decodes one byte from the middle of each character until an ambiguous
+*               (or silent) window or the end of the recording. "\0" bytes are kept, since encodeString doesn't send a
+*               terminator and the CRC byte itself is 0 when the payload XORs to 0. The last byte is checked as the CRC
+**/
+void decodeSamples(const decoderConfig *cfg, decoderScratch *scratch, Samples *s, decodeResult *res){
+    uint32_t n = cfg->windowSize;
+    int bins[DECODER_BITS][2];
+    int byte = 0;
+    uint8_t bytes[DECODER_MAX_PAYLOAD + 1];
+    int numBytes = 0;
+
+    res->status = DECODE_NO_SYNC;
+    res->payload[0] = '\0';
+    res->payloadLength = 0;
+    res->ambiguousBits = 0;
+    res->readError = 0;
+    res->syncSample = -1;
+    res->rms = sqrtf(signalEnergy(s, 0, (int)s->length));
+
+    if(s->length < n || s->SFreq == 0){
+        return;
+    }
+
+    for(int i=0;i<DECODER_BITS;i++){
+        for(int j=0;j<2;j++){
+            bins[i][j] = freqToIdx(cfg->FreqArray[i][j], s->SFreq, n);
+            if(bins[i][j] < 0) bins[i][j] = 0;
+            if(bins[i][j] >= (int)n) bins[i][j] = n - 1;
+        }
+    }
+
+    //Sync: first window with a valid byte
+    uint32_t first = 0;
+    int found = 0;
+    for(first=0; first + n <= s->length; first += cfg->syncStep){
+        if(decodeWindow(cfg, scratch, s, bins, first, &byte, NULL) == 0){
+            found = 1;
+            break;
+        }
+    }
+    if(!found){
+        return;
+    }
+
+    //The first valid window can be on the edge of a character (or noise), look for the strongest window within one character,
+    //then centre the search on it until it stops moving
+    uint32_t pos = strongestWindow(cfg, scratch, s, bins, first, first + cfg->samplePerChar);
+    for(int i=0;i<DECODER_SYNC_PASSES;i++){
+        uint32_t from = (pos > cfg->samplePerChar/2) ? pos - cfg->samplePerChar/2 : 0;
+        uint32_t next = strongestWindow(cfg, scratch, s, bins, from, from + cfg->samplePerChar);
+        if(next == pos){
+            break;
+        }
+        pos = next;
+    }
+    res->syncSample = pos;
+
+    //Decode each character until an ambiguous byte or the end
+    for(; pos + n <= s->length && numBytes <= DECODER_MAX_PAYLOAD; pos += cfg->samplePerChar){
+        int ambiguous = decodeWindow(cfg, scratch, s, bins, pos, &byte, NULL);
+        if(ambiguous > 0){
+            res->ambiguousBits = ambiguous;
+            break;
+        }
+        bytes[numBytes++] = (uint8_t)byte;
+    }
+
+    //Last byte is the CRC of the others
+    uint8_t CRC = 0;
+    for(int i=0;i<numBytes-1;i++){
+        CRC ^= bytes[i];
+        res->payload[i] = (char)bytes[i];
+    }
+    res->payloadLength = numBytes > 0 ? numBytes - 1 : 0;
+    res->payload[res->payloadLength] = '\0';
+
+    res->status = (numBytes > 0 && CRC == bytes[numBytes-1]) ? DECODE_OK : DECODE_CRC_ERROR;
+}
+
+/**
+* Function:     decodeStatusString
+* Arguments:    status              -decodeResult status
+*               
+* Returns:      Short description of the status
+* Description:  Used for the per-file status column
+**/
+const char* decodeStatusString(int status){
+    switch(status){
+        case DECODE_OK:         return "ok";
+        case DECODE_READ_ERROR: return "read-error";
+        case DECODE_NO_SYNC:    return "no-sync";
+        case DECODE_CRC_ERROR:  return "crc-error";
+    }
+    return "unknown";
+}
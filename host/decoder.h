@@ -0,0 +1,51 @@
+#ifndef decoder_h
+#define decoder_h
+
+#include "samples.h"
+#include "fft.h"
+
+#define DECODER_BITS 8
+#define DECODER_MAX_PAYLOAD 1024
+#define DECODER_SYNC_PASSES 4
+
+#define DECODE_OK 0
+#define DECODE_READ_ERROR 1
+#define DECODE_NO_SYNC 2
+#define DECODE_CRC_ERROR 3
+
+//Same protocol as Source/main.lua and Source/fftString.lua
+typedef struct
+{
+    float FreqArray[DECODER_BITS][2];   //Frequencies for bit = 0 and bit = 1, most significant bit first
+    float threshold;                    //Minimum magnitude difference between the two frequencies of a bit
+    uint32_t samplePerChar;             //Number of samples that encode 1 character
+    uint32_t windowSize;                //FFT size (power of 2)
+    uint32_t syncStep;                  //Step used while searching for the first character
+} decoderConfig;
+
+//Per-thread buffers, so the threads only share the config and the cached FFT tables
+typedef struct
+{
+    int32_t *re;
+    int32_t *im;
+} decoderScratch;
+
+typedef struct
+{
+    int status;
+    char payload[DECODER_MAX_PAYLOAD + 1];  //Message without the CRC byte (can contain "\0", see payloadLength)
+    int payloadLength;
+    int ambiguousBits;                      //Bits under the threshold in the window that ended the message
+    int readError;                          //WAV_* code from readWav when status is DECODE_READ_ERROR
+    int64_t syncSample;                     //Start of the first character's window (-1 if not found)
+    float rms;                              //Level of the whole recording
+    double ms;                              //Time spent reading and decoding the file
+} decodeResult;
+
+void decoderDefaultConfig(decoderConfig *cfg);
+int decoderScratchInit(decoderScratch *scratch, uint32_t windowSize);
+void decoderScratchFree(decoderScratch *scratch);
+void decodeSamples(const decoderConfig *cfg, decoderScratch *scratch, Samples *s, decodeResult *res);
+const char* decodeStatusString(int status);
+
+#endif /* decoder_h */
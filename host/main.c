@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "decoder.h"
+#include "threadpool.h"
+#include "wav.h"
+
+//dosdecode: decodes directories of .wav recordings on all cores with the DSP core from src/
+
+typedef struct
+{
+    char **paths;
+    int count;
+    int capacity;
+} fileList;
+
+typedef struct
+{
+    const decoderConfig *cfg;
+    decoderScratch *scratch;        //One per worker
+    fileList *files;
+    decodeResult *results;          //One per file
+} batchData;
+
+static double nowMs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int addFile(fileList *list, const char *path){
+    if(list->count == list->capacity){
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        char **paths = realloc(list->paths, sizeof(char*) * capacity);
+        if(paths == NULL){
+            return -1;
+        }
+        list->paths = paths;
+        list->capacity = capacity;
+    }
+    list->paths[list->count] = strdup(path);
+    if(list->paths[list->count] == NULL){
+        return -1;
+    }
+    list->count++;
+    return 0;
+}
+
+static int isWav(const char *name){
+    size_t len = strlen(name);
+    return len > 4 && strcasecmp(name + len - 4, ".wav") == 0;
+}
+
+/**
+* Function:     collectFiles
+* Arguments:    list                -fileList to add to
+*               path                -File or directory given on the command line
+*               
+* Returns:      0 on success, -1 if out of memory
+* Description:  Adds path if it's a file, or every .wav under it (recursively) if it's a directory.
+*               Symbolic links to directories inside it are skipped, so a link loop can't recurse forever
+**/
+static int collectFiles(fileList *list, const char *path){
+    struct stat st;
+    if(stat(path, &st) != 0 || !S_ISDIR(st.st_mode)){
+        //Missing files are still listed, so they show up as read errors
+        return addFile(list, path);
+    }
+
+    DIR *dir = opendir(path);
+    if(dir == NULL){
+        return addFile(list, path);
+    }
+
+    struct dirent *entry;
+    int err = 0;
+    while(err == 0 && (entry = readdir(dir)) != NULL){
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0){
+            continue;
+        }
+        size_t len = strlen(path) + strlen(entry->d_name) + 2;
+        char *child = malloc(len);
+        if(child == NULL){
+            err = -1;
+            break;
+        }
+        snprintf(child, len, "%s/%s", path, entry->d_name);
+
+        if(lstat(child, &st) != 0){
+            //Removed or unreadable entry, a .wav is still listed so it shows up as a read error
+            if(isWav(entry->d_name)){
+                err = addFile(list, child);
+            }
+        }else if(S_ISDIR(st.st_mode)){
+            err = collectFiles(list, child);
+        }else if(S_ISLNK(st.st_mode) && stat(child, &st) == 0 && S_ISDIR(st.st_mode)){
+            //Linked directory, skipped
+        }else if(isWav(entry->d_name)){
+            err = addFile(list, child);
+        }
+        free(child);
+    }
+    closedir(dir);
+
+    return err;
+}
+
+static int comparePaths(const void *a, const void *b){
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+//Runs on the worker threads, one call per file
+static void decodeFile(int worker, int taskIdx, void *ctx){
+    batchData *batch = ctx;
+    decodeResult *res = &batch->results[taskIdx];
+    Samples s;
+
+    double start = nowMs();
+    int err = readWav(batch->files->paths[taskIdx], &s);
+    if(err != WAV_OK){
+        memset(res, 0, sizeof(decodeResult));
+        res->status = DECODE_READ_ERROR;
+        res->syncSample = -1;
+        res->readError = err;
+    }else{
+        decodeSamples(batch->cfg, &batch->scratch[worker], &s, res);
+        freeWav(&s);
+    }
+    res->ms = nowMs() - start;
+}
+
+static void printPayload(const decodeResult *res){
+    for(int i=0;i<res->payloadLength;i++){
+        unsigned char c = (unsigned char)res->payload[i];
+        if(c == '\\'){
+            fputs("\\\\", stdout);
+        }else if(c < 0x20 || c >= 0x7F){
+            printf("\\x%02X", c);
+        }else{
+            putchar(c);
+        }
+    }
+}
+
+static void usage(const char *name){
+    fprintf(stderr,
+        "usage: %s [-j threads] [-t threshold] [-c samplePerChar] [-w windowSize] [-s syncStep] path...\n"
+        "  Decodes every .wav file given (directories are searched recursively)\n"
+        "  stdout: file, status, ms, syncSample, rms, ambiguousBits, payload (tab separated)\n"
+        "  stderr: totals\n", name);
+}
+
+int main(int argc, char **argv){
+    decoderConfig cfg;
+    decoderDefaultConfig(&cfg);
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    while((opt = getopt(argc, argv, "j:t:c:w:s:h")) != -1){
+        switch(opt){
+            case 'j': threads = atol(optarg); break;
+            case 't': cfg.threshold = (float)atof(optarg); break;
+            case 'c': cfg.samplePerChar = (uint32_t)atol(optarg); break;
+            case 'w': cfg.windowSize = (uint32_t)atol(optarg); break;
+            case 's': cfg.syncStep = (uint32_t)atol(optarg); break;
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+    if(optind >= argc || threads < 1 || cfg.samplePerChar == 0 || cfg.syncStep == 0){
+        usage(argv[0]);
+        return 2;
+    }
+
+    if(cfg.windowSize < 2 || (cfg.windowSize & (cfg.windowSize - 1)) != 0){
+        fprintf(stderr, "windowSize must be a power of 2 (got %u)\n", cfg.windowSize);
+        return 2;
+    }
+
+    //Creates the FFT tables (twiddle factors and hamming window) before the threads start, they only read them
+    //(bigger sizes have no tables, their FFTs compute the twiddle factors as they go)
+    if(cfg.windowSize <= (1u << MAX_PLAN_LOG2) && fft_get_plan(cfg.windowSize) == NULL){
+        fprintf(stderr, "not enough memory for the FFT tables\n");
+        return 2;
+    }
+
+    fileList files = {NULL, 0, 0};
+    for(int i=optind;i<argc;i++){
+        if(collectFiles(&files, argv[i]) != 0){
+            fprintf(stderr, "Out of memory while listing %s\n", argv[i]);
+            return 1;
+        }
+    }
+    //Stable output order, whatever order the threads finish in
+    qsort(files.paths, files.count, sizeof(char*), comparePaths);
+
+    batchData batch;
+    batch.cfg = &cfg;
+    batch.files = &files;
+    batch.results = calloc(files.count > 0 ? files.count : 1, sizeof(decodeResult));
+    batch.scratch = calloc(threads, sizeof(decoderScratch));
+    if(batch.results == NULL || batch.scratch == NULL){
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for(long w=0;w<threads;w++){
+        if(decoderScratchInit(&batch.scratch[w], cfg.windowSize) != 0){
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    double start = nowMs();
+    if(runWorkStealing((int)threads, files.count, decodeFile, &batch) != 0){
+        fprintf(stderr, "Could not start the worker threads\n");
+        return 1;
+    }
+    double wall = nowMs() - start;
+
+    //Per-file results and totals
+    int counts[4] = {0, 0, 0, 0};
+    double cpu = 0, maxMs = 0;
+    for(int i=0;i<files.count;i++){
+        const decodeResult *res = &batch.results[i];
+        printf("%s\t%s\t%.2f\t%lld\t%.1f\t%d\t", files.paths[i], decodeStatusString(res->status), res->ms,
+            (long long)res->syncSample, res->rms, res->ambiguousBits);
+        if(res->status == DECODE_READ_ERROR){
+            fputs(wavErrorString(res->readError), stdout);
+        }else{
+            printPayload(res);
+        }
+        putchar('\n');
+
+        if(res->status >= 0 && res->status < 4) counts[res->status]++;
+        cpu += res->ms;
+        if(res->ms > maxMs) maxMs = res->ms;
+    }
+
+    fprintf(stderr, "files: %d  ok: %d  crc-error: %d  no-sync: %d  read-error: %d\n",
+        files.count, counts[DECODE_OK], counts[DECODE_CRC_ERROR], counts[DECODE_NO_SYNC], counts[DECODE_READ_ERROR]);
+    fprintf(stderr, "threads: %ld  wall: %.1f ms  per file: %.2f ms mean, %.2f ms max\n",
+        threads, wall, files.count > 0 ? cpu / files.count : 0.0, maxMs);
+
+    for(long w=0;w<threads;w++){
+        decoderScratchFree(&batch.scratch[w]);
+    }
+    for(int i=0;i<files.count;i++){
+        free(files.paths[i]);
+    }
+    free(files.paths);
+    free(batch.scratch);
+    free(batch.results);
+    fft_plan_cache_free();
+
+    return (counts[DECODE_OK] == files.count) ? 0 : 1;
+}
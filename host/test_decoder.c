@@ -0,0 +1,104 @@
+#include <string.h>
+#include "decoder.h"
+
+#define TEST_SFREQ 44100
+#define TEST_AMP 600
+#define TEST_LEAD 5000
+
+/**
+* Function:     encodeMessage
+* Arguments:    cfg                 -decoderConfig with the frequencies and samplePerChar
+*               msg                 -Bytes to send (can contain "\0")
+*               len                 -Number of bytes in msg
+*               s                   -Samples to fill in (free s->data when done)
+*
+* Returns:      0 on success, -1 if out of memory
+* Description:  Same signal as encodeString (message + CRCEncoder byte, one hamming windowed character per samplePerChar),
+*               after TEST_LEAD samples of silence and followed by one character of silence
+**/
+static int encodeMessage(const decoderConfig *cfg, const uint8_t *msg, int len, Samples *s){
+    uint32_t spc = cfg->samplePerChar;
+    uint32_t length = TEST_LEAD + (uint32_t)(len + 2) * spc;
+
+    s->data = calloc(length, sizeof(short int));
+    if(s->data == NULL){
+        return -1;
+    }
+    s->SFormat = kSound16bitMono;
+    s->SFreq = TEST_SFREQ;
+    s->length = length;
+    s->file = NULL;
+    s->dataOffset = 0;
+    s->chunkSize = length;
+    s->chunkStart = 0;
+    s->chunkLength = length;
+
+    uint8_t CRC = 0;
+    for(int c=0;c<=len;c++){
+        uint8_t byte = (c < len) ? msg[c] : CRC;
+        if(c < len) CRC ^= msg[c];
+
+        uint32_t start = TEST_LEAD + (uint32_t)c * spc;
+        for(int b=0;b<DECODER_BITS;b++){
+            float freq = cfg->FreqArray[b][(byte >> (DECODER_BITS - 1 - b)) & 1];
+            for(uint32_t i=0;i<spc;i++){
+                float w = 0.54f - 0.46f * cosf(2 * PI * i / (spc - 1));
+                s->data[start + i] += (short int)(TEST_AMP * sinf(freq * ((float)(start + i) / TEST_SFREQ) * 2 * PI) * w);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+* Function:     expectDecode
+* Arguments:    name                -Test name to print
+*               msg                 -Bytes to send
+*               len                 -Number of bytes in msg
+*
+* Returns:      0 if the whole message decoded with a valid CRC, 1 otherwise
+* Description:  Encodes msg, decodes it with the default config and compares the payload
+**/
+static int expectDecode(const char *name, const uint8_t *msg, int len){
+    decoderConfig cfg;
+    decoderScratch scratch;
+    decodeResult res;
+    Samples s;
+
+    decoderDefaultConfig(&cfg);
+    if(decoderScratchInit(&scratch, cfg.windowSize) != 0 || encodeMessage(&cfg, msg, len, &s) != 0){
+        printf("FAIL %s: out of memory\n", name);
+        return 1;
+    }
+
+    decodeSamples(&cfg, &scratch, &s, &res);
+    free(s.data);
+    decoderScratchFree(&scratch);
+
+    if(res.status != DECODE_OK || res.payloadLength != len || memcmp(res.payload, msg, (size_t)len) != 0){
+        printf("FAIL %s: %s, %d of %d bytes\n", name, decodeStatusString(res.status), res.payloadLength, len);
+        return 1;
+    }
+    printf("ok   %s\n", name);
+    return 0;
+}
+
+int main(void){
+    int failed = 0;
+
+    const char *hello = "Hello, world!";
+    failed += expectDecode("message", (const uint8_t*)hello, (int)strlen(hello));
+
+    //An even number of the same byte XORs to 0, so the CRC byte is "\0"
+    uint8_t repeated[20];
+    memset(repeated, 'x', sizeof(repeated));
+    failed += expectDecode("zero CRC", repeated, (int)sizeof(repeated));
+
+    const uint8_t withZero[] = { 'a', 0, 'b' };
+    failed += expectDecode("\\0 in the payload", withZero, (int)sizeof(withZero));
+
+    fft_plan_cache_free();
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "threadpool.h"
+
+//Each worker owns a deque of task indices: it pops from the tail, thieves take from the head
+typedef struct
+{
+    int *tasks;
+    int head;
+    int tail;
+    pthread_mutex_t lock;
+} taskDeque;
+
+typedef struct
+{
+    taskDeque *deques;
+    int numWorkers;
+    poolTask task;
+    void *ctx;
+} poolData;
+
+typedef struct
+{
+    poolData *pool;
+    int id;
+} workerArg;
+
+static int popTail(taskDeque *d, int *taskIdx){
+    int found = 0;
+    pthread_mutex_lock(&d->lock);
+    if(d->tail > d->head){
+        d->tail--;
+        *taskIdx = d->tasks[d->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+static int stealHead(taskDeque *d, int *taskIdx){
+    int found = 0;
+    pthread_mutex_lock(&d->lock);
+    if(d->tail > d->head){
+        *taskIdx = d->tasks[d->head];
+        d->head++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+static void* workerLoop(void *arg){
+    workerArg *w = arg;
+    poolData *pool = w->pool;
+    int taskIdx;
+
+    for(;;){
+        if(popTail(&pool->deques[w->id], &taskIdx)){
+            pool->task(w->id, taskIdx, pool->ctx);
+            continue;
+        }
+
+        //Own deque is empty, try the others starting with the next worker
+        int stolen = 0;
+        for(int i=1;i<pool->numWorkers && !stolen;i++){
+            stolen = stealHead(&pool->deques[(w->id + i) % pool->numWorkers], &taskIdx);
+        }
+        if(!stolen){
+            //Tasks never spawn new tasks, so once every deque is empty the work is done
+            break;
+        }
+        pool->task(w->id, taskIdx, pool->ctx);
+    }
+
+    return NULL;
+}
+
+/**
+* Function:     runWorkStealing
+* Arguments:    numWorkers          -Number of threads to run
+*               numTasks            -Number of tasks
+*               task                -Function called once per task
+*               ctx                 -Pointer passed to every call of task
+*               
+* Returns:      0 on success, -1 if the deques couldn't be allocated
+* Description:  Splits the tasks in contiguous blocks, one per worker, and lets idle workers steal from the
+*               others so a few slow files don't leave the rest of the cores waiting. Blocks until all tasks ran
+**/
+int runWorkStealing(int numWorkers, int numTasks, poolTask task, void *ctx){
+    if(numWorkers < 1) numWorkers = 1;
+    if(numWorkers > numTasks) numWorkers = numTasks > 0 ? numTasks : 1;
+
+    poolData pool;
+    pool.numWorkers = numWorkers;
+    pool.task = task;
+    pool.ctx = ctx;
+    pool.deques = calloc(numWorkers, sizeof(taskDeque));
+    pthread_t *threads = calloc(numWorkers, sizeof(pthread_t));
+    workerArg *args = calloc(numWorkers, sizeof(workerArg));
+    int *tasks = malloc(sizeof(int) * (numTasks > 0 ? numTasks : 1));
+
+    if(pool.deques == NULL || threads == NULL || args == NULL || tasks == NULL){
+        free(pool.deques);
+        free(threads);
+        free(args);
+        free(tasks);
+        return -1;
+    }
+
+    for(int i=0;i<numTasks;i++){
+        tasks[i] = i;
+    }
+    for(int w=0;w<numWorkers;w++){
+        pool.deques[w].tasks = tasks;
+        pool.deques[w].head = (int)((long)numTasks * w / numWorkers);
+        pool.deques[w].tail = (int)((long)numTasks * (w + 1) / numWorkers);
+        pthread_mutex_init(&pool.deques[w].lock, NULL);
+    }
+
+    int started = 0;
+    for(int w=0;w<numWorkers;w++){
+        args[w].pool = &pool;
+        args[w].id = w;
+        if(pthread_create(&threads[w], NULL, workerLoop, &args[w]) != 0){
+            break;
+        }
+        started++;
+    }
+    //If a thread couldn't start, the ones that did steal its tasks (or this thread runs them all)
+    if(started == 0){
+        workerLoop(&args[0]);
+    }
+    for(int w=0;w<started;w++){
+        pthread_join(threads[w], NULL);
+    }
+
+    for(int w=0;w<numWorkers;w++){
+        pthread_mutex_destroy(&pool.deques[w].lock);
+    }
+    free(pool.deques);
+    free(threads);
+    free(args);
+    free(tasks);
+
+    return 0;
+}
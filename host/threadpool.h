@@ -0,0 +1,9 @@
+#ifndef threadpool_h
+#define threadpool_h
+
+//Runs task(worker, taskIdx, ctx) for every taskIdx in [0, numTasks), worker is in [0, numWorkers)
+typedef void (*poolTask)(int worker, int taskIdx, void *ctx);
+
+int runWorkStealing(int numWorkers, int numTasks, poolTask task, void *ctx);
+
+#endif /* threadpool_h */
@@ -0,0 +1,134 @@
+#include <string.h>
+#include "wav.h"
+
+static uint32_t read_u32(const unsigned char *p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_u16(const unsigned char *p){
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+* Function:     readWav
+* Arguments:    path                -Path of the .wav file
+*               s                   -Samples to fill in (data is allocated with malloc)
+*               
+* Returns:      WAV_OK or one of the WAV_*_ERROR codes
+* Description:  Reads a PCM .wav file (8 or 16 bit, any number of channels) and mixes it down to 16 bit mono,
+*               the same layout samplelib.samples gets from a playdate.sound.sample
+**/
+int readWav(const char *path, Samples *s){
+    s->data = NULL;
+    s->file = NULL;
+    s->length = 0;
+
+    FILE *fp = fopen(path, "rb");
+    if(fp == NULL){
+        return WAV_OPEN_ERROR;
+    }
+
+    unsigned char header[12];
+    if(fread(header, 1, 12, fp) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0){
+        fclose(fp);
+        return WAV_FORMAT_ERROR;
+    }
+
+    uint16_t channels = 0, bits = 0;
+    uint32_t SFreq = 0;
+    int haveFmt = 0;
+
+    //Walk the chunks until the data chunk (fmt must come before it)
+    unsigned char chunk[8];
+    while(fread(chunk, 1, 8, fp) == 8){
+        uint32_t size = read_u32(chunk + 4);
+
+        if(memcmp(chunk, "fmt ", 4) == 0){
+            unsigned char fmt[16];
+            if(size < 16 || fread(fmt, 1, 16, fp) != 16){
+                break;
+            }
+            uint16_t format = read_u16(fmt);
+            channels = read_u16(fmt + 2);
+            SFreq = read_u32(fmt + 4);
+            bits = read_u16(fmt + 14);
+            //1 = PCM, 0xFFFE = extensible (still integer PCM for 8/16 bit)
+            if((format != 1 && format != 0xFFFE) || channels == 0 || (bits != 8 && bits != 16)){
+                break;
+            }
+            haveFmt = 1;
+            fseek(fp, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        }else if(memcmp(chunk, "data", 4) == 0 && haveFmt){
+            uint32_t frameSize = channels * (bits / 8);
+            uint32_t frames = size / frameSize;
+
+            unsigned char *raw = malloc((size_t)frames * frameSize);
+            s->data = malloc(sizeof(short int) * (frames > 0 ? frames : 1));
+            if(raw == NULL || s->data == NULL){
+                free(raw);
+                freeWav(s);
+                fclose(fp);
+                return WAV_MEMORY_ERROR;
+            }
+
+            //Accept truncated captures, keeping the frames that are there
+            frames = (uint32_t)(fread(raw, 1, (size_t)frames * frameSize, fp) / frameSize);
+
+            for(uint32_t i=0;i<frames;i++){
+                int32_t sum = 0;
+                for(uint16_t c=0;c<channels;c++){
+                    const unsigned char *p = raw + (size_t)i * frameSize + c * (bits / 8);
+                    sum += (bits == 16) ? (int16_t)read_u16(p) : ((int32_t)p[0] - 128) << 8;
+                }
+                s->data[i] = (short int)(sum / channels);
+            }
+            free(raw);
+
+            s->SFormat = kSound16bitMono;
+            s->SFreq = SFreq;
+            s->length = frames;
+            s->file = NULL;
+            s->dataOffset = 0;
+            s->chunkSize = frames;
+            s->chunkStart = 0;
+            s->chunkLength = frames;
+            fclose(fp);
+            return WAV_OK;
+        }else{
+            fseek(fp, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+
+    fclose(fp);
+    return WAV_FORMAT_ERROR;
+}
+
+/**
+* Function:     freeWav
+* Arguments:    s                   -Samples filled in by readWav
+*               
+* Returns:
+* Description:  Frees memory
+**/
+void freeWav(Samples *s){
+    free(s->data);
+    s->data = NULL;
+    s->length = 0;
+}
+
+/**
+* Function:     wavErrorString
+* Arguments:    err                 -Error code returned by readWav
+*               
+* Returns:      Short description of the error
+* Description:  Used for the per-file status column
+**/
+const char* wavErrorString(int err){
+    switch(err){
+        case WAV_OK:            return "ok";
+        case WAV_OPEN_ERROR:    return "open-error";
+        case WAV_FORMAT_ERROR:  return "format-error";
+        case WAV_MEMORY_ERROR:  return "memory-error";
+    }
+    return "unknown-error";
+}
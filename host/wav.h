@@ -0,0 +1,15 @@
+#ifndef wav_h
+#define wav_h
+
+#include "samples.h"
+
+#define WAV_OK 0
+#define WAV_OPEN_ERROR -1
+#define WAV_FORMAT_ERROR -2
+#define WAV_MEMORY_ERROR -3
+
+int readWav(const char *path, Samples *s);
+void freeWav(Samples *s);
+const char* wavErrorString(int err);
+
+#endif /* wav_h */
@@ -1,10 +1,7 @@
 #include "samples.h"
 #include "fft.h"
 
-#define PI 3.1415926535897932384626433832795028841971f
-#define FIXED_SHIFT 16  // Fixed-point shift (16-bit fractional part)
-#define FIXED_SCALE (1 << FIXED_SHIFT)  // 2^16 for scaling float to fixed-point
-
+#ifndef DOS_HOST_BUILD
 static PlaydateAPI* pd = NULL;
 
 //FFT Struture and functions ---------------------------------
@@ -20,27 +17,29 @@ typedef struct
 int newFFT(lua_State* L);
 int free_fft(lua_State* L);
 int runFFT(lua_State* L);
+int runIFFT(lua_State* L);
 int getAbsFFT(lua_State* L);
 int getPhaseFFT(lua_State* L);
 int getLengthFFT(lua_State* L);
 int DomainFFT(lua_State* L);
 int getAbsMaxFFT(lua_State* L);
+int freeTablesFFT(lua_State* L);
 
 //Real FFT algorithm
 uint32_t addPading(fftData* f);
-void fft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n);
-void apply_hamming_window(int32_t *real, int n);
 
 static const lua_reg fftlib[] =
 {
 	{ "new",            newFFT},
 	{ "free",           free_fft },
     { "runFFT",           runFFT },
+    { "runIFFT",          runIFFT },
 	{ "getAbsFreq",      getAbsFFT },
     { "getPhaseFreq",      getPhaseFFT },
     { "getLength",	    getLengthFFT },
 	{ "isFreqDomain",  DomainFFT },
     { "getAbsMax",  getAbsMaxFFT },
+    { "freeTables",  freeTablesFFT },
 	{ NULL, NULL }
 };
 //------------------------------------------------------------
@@ -91,13 +90,24 @@ int newFFT(lua_State* L){
     f->data_re = pd->system->realloc(NULL, (sizeof(int32_t )* size));
     f->data_im = pd->system->realloc(NULL, (sizeof(int32_t ) * size));
 
-    int i=0,j=0;
+    int i=0,j=0,k=0;
+    int available = 0;
+    const short int* data;
 
-    for(i=startIdx;i<endIdx;i++){
-        f->data_re[j] = ((int32_t)s->data[i]);
-        f->data_im[j] = 0;
+    //Works the same for samples in memory or streamed from a file
+    for(i=startIdx;i<endIdx;){
+        if((data = getSampleChunk(s, i, endIdx, &available)) == NULL) break;
+        for(k=0;k<available && i<endIdx;k++,i++){
+            f->data_re[j] = ((int32_t)data[k]);
+            f->data_im[j] = 0;
 
-        j++;
+            j++;
+        }
+    }
+    //Whatever couldn't be read from the file is silence
+    for(;j<size;j++){
+        f->data_re[j] = 0;
+        f->data_im[j] = 0;
     }
 
     f->FreqDomain = 0;
@@ -135,10 +145,11 @@ int free_fft(lua_State* L){
 *               
 * Returns:
 * Description:  Runs Padding + hamming_window + FFT
+*               The spectrum is kept unscaled, so runIFFT can invert it exactly. getAbsFreq and getAbsMax scale it (see fft_bin_scale)
 **/
 int runFFT(lua_State* L){
     fftData* f = pd->lua->getArgObject(1, "fftlib.fft", NULL);
-    if((f == NULL) || (f->data_re == NULL) || (f->data_im == NULL)){
+    if((f == NULL) || (f->data_re == NULL) || (f->data_im == NULL) || (f->FreqDomain == 1)){
         return 0;
     }
 
@@ -147,21 +158,35 @@ int runFFT(lua_State* L){
     apply_hamming_window(f->data_re, n);
     fft_fixed_iterative(f->data_re,f->data_im,n);
 
-    
-    //Normalizing amplitude to be the same as the input signal
-    f->data_re[0] =(int32_t) (f->data_re[0]*1.87f/n);
-    f->data_im[0] =(int32_t) (f->data_im[0]*1.87f/n);
-    for(int i=1;i<n;i++){
-        f->data_re[i] =(int32_t) (f->data_re[i] * 3.74f/(n));
-        f->data_im[i] =(int32_t) (f->data_im[i] * 3.74f/(n));
+    //Change the domain indicator
+    f->FreqDomain = 1;
+
+    return 0;
+}
+
+/**
+* Function:     runIFFT
+* Arguments:    f                   -fftlib.fft object in the frequency domain (after runFFT)
+*               
+* Returns:
+* Description:  Undoes runFFT: runs the inverse FFT and removes the hamming window
+*               The padding added by runFFT is kept, so getLength still returns the padded length
+*               Samples near both ends are less precise, since dividing by the hamming window (close to 0.08 there)
+*               amplifies the rounding errors about 12 times (see the README for the measured error)
+**/
+int runIFFT(lua_State* L){
+    fftData* f = pd->lua->getArgObject(1, "fftlib.fft", NULL);
+    if((f == NULL) || (f->data_re == NULL) || (f->data_im == NULL) || (f->FreqDomain == 0)){
+        return 0;
     }
 
+    int n = f->length;
+
+    ifft_fixed_iterative(f->data_re,f->data_im,n);
+    remove_hamming_window(f->data_re, n);
+
     //Change the domain indicator
-    if(f->FreqDomain == 0){
-        f->FreqDomain = 1;  
-    }else{
-        f->FreqDomain = 0; 
-    }
+    f->FreqDomain = 0;
 
     return 0;
 }
@@ -192,7 +217,7 @@ int getAbsFFT(lua_State* L){
         idx=idx+f->length;
     }
 
-    float absVal = sqrtf(powf((float)f->data_re[idx],2) + powf((float)f->data_im[idx],2));
+    float absVal = sqrtf(powf((float)f->data_re[idx],2) + powf((float)f->data_im[idx],2)) * fft_bin_scale(idx, f->length);
     
     pd->lua->pushFloat(absVal);
 
@@ -218,6 +243,7 @@ int getPhaseFFT(lua_State* L){
 
     //Since we are in using a descreate singal, the frequency domain signal is infinite and repeats every f->length
     //These while loops makes sure the user still receives the correct Phase Value
+    //(the phase doesn't depend on the amplitude scale, so the unscaled spectrum is used as is)
     while(idx > (int)f->length){
         idx=idx-f->length;
     }
@@ -300,7 +326,7 @@ int getAbsMaxFFT(lua_State* L){
     int MaxFreq = 0;
 
     for(int i = startIdx;i<endIdx;i++){
-        float absVal = sqrtf(powf((float)f->data_re[i],2) + powf((float)f->data_im[i],2));
+        float absVal = sqrtf(powf((float)f->data_re[i],2) + powf((float)f->data_im[i],2)) * fft_bin_scale(i, f->length);
         if(absVal>Max){
             Max = absVal;
             MaxFreq = i;
@@ -314,8 +340,24 @@ int getAbsMaxFFT(lua_State* L){
     return 2;
 }
 
+/**
+* Function:     freeTablesFFT
+* Arguments:
+*               
+* Returns:
+* Description:  Frees the cached FFT tables (twiddle factors, bit-reversal and hamming window) of every size used so far
+*               They are created again by the next FFT of each size, so this is only worth it after switching to another size
+**/
+int freeTablesFFT(lua_State* L){
+    fft_plan_cache_free();
+
+    return 0;
+}
+#endif /* DOS_HOST_BUILD */
+
 
 //The Real FFT----------------------------
+#ifndef DOS_HOST_BUILD
 /**
 * Function:     addPading
 * Arguments:    f                   -fftlib.fft object to analyse
@@ -346,6 +388,7 @@ uint32_t addPading(fftData* f){
 
     return newN;
 }
+#endif /* DOS_HOST_BUILD */
 
 /**
 * Function:     fft
@@ -359,7 +402,7 @@ uint32_t addPading(fftData* f){
 
 // Converts a float to fixed-point
 static inline int32_t float_to_fixed(float x) {
-    return (int32_t)(x * FIXED_SCALE);
+    return (int32_t)lrintf(x * FIXED_SCALE);
 }
 
 // Converts fixed-point back to float
@@ -367,11 +410,6 @@ static inline float fixed_to_float(int32_t x) {
     return (float)x / FIXED_SCALE;
 }
 
-// Fixed-point multiplication (Q16)
-static inline int32_t fixed_mul(int32_t a, int32_t b) {
-    return (int32_t)((int64_t)a * b >> FIXED_SHIFT);
-}
-
 // Fixed-point FFT butterfly operation
 static inline void fixed_butterfly(int32_t *real1, int32_t *imag1, int32_t *real2, int32_t *imag2, int32_t wr, int32_t wi) {
     // Fixed-point complex multiplication and addition
@@ -384,6 +422,11 @@ static inline void fixed_butterfly(int32_t *real1, int32_t *imag1, int32_t *real
     *imag1 = *imag1 + ti;
 }
 
+// Integer division rounded to the nearest
+static inline int32_t div_round(int32_t a, int32_t b) {
+    return (a >= 0) ? (a + b / 2) / b : -((-a + b / 2) / b);
+}
+
 // Bit-reversal function (unchanged)
 static inline uint32_t reverse_bits(uint32_t n, uint32_t log2n) {
     uint32_t result = 0;
@@ -395,7 +438,18 @@ static inline uint32_t reverse_bits(uint32_t n, uint32_t log2n) {
 }
 
 // Iterative Fixed-Point FFT
-void fft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n) {
+// Returns 0, or -1 if n isn't a power of 2 (the arrays are left untouched)
+int fft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n) {
+    if (n < 2) {
+        return 0;
+    }
+    if ((n & (n - 1)) != 0) {
+        return -1;
+    }
+
+    // Bit-reversal and twiddle factors are computed once per size, not on every FFT
+    // Without tables (sizes above 2^MAX_PLAN_LOG2, or out of memory) they are computed as they are needed
+    const fftPlan *p = fft_get_plan(n);
     uint32_t log2n = 0;
     for (uint32_t i = n; i > 1; i >>= 1) {
         log2n++;
@@ -403,7 +457,7 @@ void fft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n) {
 
     // Bit-reversal permutation
     for (uint32_t i = 0; i < n; i++) {
-        uint32_t j = reverse_bits(i, log2n);
+        uint32_t j = (p != NULL) ? p->bitrev[i] : reverse_bits(i, log2n);
         if (i < j) {
             // Swap real and imaginary parts
             int32_t temp_real = real[i];
@@ -416,30 +470,60 @@ void fft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n) {
         }
     }
 
-    // FFT computation
+    // FFT computation, stage m uses every (n/m)th twiddle factor of the table
     for (uint32_t s = 1; s <= log2n; s++) {
         uint32_t m = 1 << s;
         uint32_t m2 = m >> 1;
-
-        // Calculate fixed-point twiddle factors (precompute cos/sin)
-        int32_t wm_real = float_to_fixed(cosf(-2.0f * PI / m));
-        int32_t wm_imag = float_to_fixed(sinf(-2.0f * PI / m));
-
-        for (uint32_t k = 0; k < n; k += m) {
-            int32_t w_real = float_to_fixed(1.0f);
-            int32_t w_imag = 0;
+        uint32_t stride = n / m;
+
+        for (uint32_t j = 0; j < m2; j++) {
+            int32_t w_real, w_imag;
+            if (p != NULL) {
+                w_real = p->tw_re[j * stride];
+                w_imag = p->tw_im[j * stride];
+            } else {
+                w_real = float_to_fixed(cosf(-2.0f * PI * j / m));
+                w_imag = float_to_fixed(sinf(-2.0f * PI * j / m));
+            }
 
             // Perform FFT butterfly operations
-            for (uint32_t j = 0; j < m2; j++) {
+            for (uint32_t k = 0; k < n; k += m) {
                 fixed_butterfly(&real[k + j], &imag[k + j], &real[k + j + m2], &imag[k + j + m2], w_real, w_imag);
-
-                // Update twiddle factors for the next butterfly
-                int32_t temp_real = fixed_mul(w_real, wm_real) - fixed_mul(w_imag, wm_imag);
-                w_imag = fixed_mul(w_real, wm_imag) + fixed_mul(w_imag, wm_real);
-                w_real = temp_real;
             }
         }
     }
+
+    return 0;
+}
+
+/**
+* Function:     ifft_fixed_iterative
+* Arguments:    *real               -int32_t pointer to the real values of the spectrum
+*               *imag               -int32_t pointer to the imaginary values of the spectrum
+*               n                   -int number of elements in the arrays (power of 2)
+*               
+* Returns:      0, or -1 if n isn't a power of 2
+* Description:  Runs the inverse FFT and stores the results in the input vectors
+*               Uses ifft(X) = conj(fft(conj(X)))/n so it shares the forward butterflies
+**/
+int ifft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n) {
+    if (n >= 2 && (n & (n - 1)) != 0) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        imag[i] = -imag[i];
+    }
+
+    fft_fixed_iterative(real, imag, n);
+
+    // Rounded division, truncating would pull every sample towards 0
+    for (uint32_t i = 0; i < n; i++) {
+        real[i] = div_round(real[i], (int32_t)n);
+        imag[i] = -div_round(imag[i], (int32_t)n);
+    }
+
+    return 0;
 }
 
 /**
@@ -451,7 +535,159 @@ void fft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n) {
 * Description:  Applies a hamming window to the samples
 **/
 void apply_hamming_window(int32_t  *real, int n) {
+    // FFT sizes read the window from the cached table instead of calling cosf for every sample
+    const fftPlan *p = (n >= 2 && (n & (n - 1)) == 0) ? fft_get_plan(n) : NULL;
+    for (int i = 0; i < n; i++) {
+        float w = (p != NULL) ? p->window[i] : (0.54f - 0.46f * cosf(2 * PI * i / (n - 1)));
+        real[i] =(int32_t)lrintf(real[i] * w);
+    }
+}
+
+/**
+* Function:     remove_hamming_window
+* Arguments:    *real               -int32_t pointer to the real values of the windowed sample
+*               n                   -int number of elements in the arrays
+*               
+* Returns:
+* Description:  Divides out the hamming window applied by apply_hamming_window (its minimum is 0.08, so it never divides by 0)
+**/
+void remove_hamming_window(int32_t  *real, int n) {
+    if(n < 2) return;
+    const fftPlan *p = ((n & (n - 1)) == 0) ? fft_get_plan(n) : NULL;
     for (int i = 0; i < n; i++) {
-        real[i] =(uint32_t) (real[i] * (0.54f - 0.46f * cosf(2 * PI * i / (n - 1))));
+        float w = (p != NULL) ? p->window[i] : (0.54f - 0.46f * cosf(2 * PI * i / (n - 1)));
+        real[i] =(int32_t)lrintf(real[i] / w);
+    }
+}
+/**
+* Function:     fft_bin_scale
+* Arguments:    idx                 -int bin of the spectrum
+*               n                   -int number of elements in the spectrum
+*               
+* Returns:      Factor that gives the bin the same amplitude as the input signal
+* Description:  runFFT keeps the spectrum unscaled, this is the normalization of a hamming windowed spectrum (1.87/n for DC, 3.74/n for the other bins)
+**/
+float fft_bin_scale(uint32_t idx, uint32_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    return ((idx % n) == 0) ? 1.87f / n : 3.74f / n;
+}
+
+//FFT Plans--------------------------------
+// Allocator for the plans (the Playdate heap on the device, the C heap in the host tools)
+static void* dsp_realloc(void* ptr, size_t size) {
+#ifdef DOS_HOST_BUILD
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    return realloc(ptr, size);
+#else
+    return pd->system->realloc(ptr, size);
+#endif
+}
+
+static fftPlan* fft_plan_new(uint32_t n);
+static void fft_plan_free(fftPlan* p);
+
+/**
+* Function:     fft_plan_new
+* Arguments:    n                   -int FFT size (power of 2)
+*               
+* Returns:      p                   -fftPlan with the tables for size n (NULL if n isn't a power of 2 or out of memory)
+* Description:  Precomputes the bit-reversal, twiddle factor and hamming window tables for size n
+*               The plan is never written after this, so one plan can be shared between threads
+**/
+static fftPlan* fft_plan_new(uint32_t n) {
+    if (n < 2 || (n & (n - 1)) != 0) {
+        return NULL;
+    }
+
+    fftPlan *p = dsp_realloc(NULL, sizeof(fftPlan));
+    if (p == NULL) {
+        return NULL;
+    }
+    p->n = n;
+    p->log2n = 0;
+    for (uint32_t i = n; i > 1; i >>= 1) {
+        p->log2n++;
+    }
+    p->bitrev = dsp_realloc(NULL, sizeof(uint32_t) * n);
+    p->tw_re = dsp_realloc(NULL, sizeof(int32_t) * (n / 2));
+    p->tw_im = dsp_realloc(NULL, sizeof(int32_t) * (n / 2));
+    p->window = dsp_realloc(NULL, sizeof(float) * n);
+
+    if (p->bitrev == NULL || p->tw_re == NULL || p->tw_im == NULL || p->window == NULL) {
+        fft_plan_free(p);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        p->bitrev[i] = reverse_bits(i, p->log2n);
+        p->window[i] = 0.54f - 0.46f * cosf(2 * PI * i / (n - 1));
     }
-}
\ No newline at end of file
+    for (uint32_t j = 0; j < n / 2; j++) {
+        p->tw_re[j] = float_to_fixed(cosf(-2.0f * PI * j / n));
+        p->tw_im[j] = float_to_fixed(sinf(-2.0f * PI * j / n));
+    }
+
+    return p;
+}
+
+/**
+* Function:     fft_get_plan
+* Arguments:    n                   -int FFT size (power of 2, up to 2^MAX_PLAN_LOG2)
+*               
+* Returns:      p                   -Cached fftPlan for size n (NULL if n isn't valid or out of memory)
+* Description:  Creates the plan for size n the first time it is needed and keeps it for the next FFTs of that size
+*               Creating a plan isn't thread-safe: host tools call this for their sizes before starting threads
+**/
+static fftPlan* planCache[MAX_PLAN_LOG2 + 1];
+
+const fftPlan* fft_get_plan(uint32_t n) {
+    uint32_t log2n = 0;
+    for (uint32_t i = n; i > 1; i >>= 1) {
+        log2n++;
+    }
+    if (n < 2 || (n & (n - 1)) != 0 || log2n > MAX_PLAN_LOG2) {
+        return NULL;
+    }
+
+    if (planCache[log2n] == NULL) {
+        planCache[log2n] = fft_plan_new(n);
+    }
+    return planCache[log2n];
+}
+
+/**
+* Function:     fft_plan_cache_free
+* Arguments:
+*               
+* Returns:
+* Description:  Frees every cached plan (fftlib.fft.freeTables, and on kEventTerminate). The next FFT of each size creates it again
+**/
+void fft_plan_cache_free(void) {
+    for (int i = 0; i <= MAX_PLAN_LOG2; i++) {
+        fft_plan_free(planCache[i]);
+        planCache[i] = NULL;
+    }
+}
+
+/**
+* Function:     fft_plan_free
+* Arguments:    p                   -fftPlan to free
+*               
+* Returns:
+* Description:  Frees memory
+**/
+static void fft_plan_free(fftPlan* p) {
+    if (p == NULL) {
+        return;
+    }
+    dsp_realloc(p->bitrev, 0);
+    dsp_realloc(p->tw_re, 0);
+    dsp_realloc(p->tw_im, 0);
+    dsp_realloc(p->window, 0);
+    dsp_realloc(p, 0);
+}
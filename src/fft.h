@@ -1,12 +1,46 @@
-#ifndef samples_h
-#define samples_h
+#ifndef fft_h
+#define fft_h
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdint.h>
+
+#define PI 3.1415926535897932384626433832795028841971f
+#define FIXED_SHIFT 16  // Fixed-point shift (16-bit fractional part)
+#define FIXED_SCALE (1 << FIXED_SHIFT)  // 2^16 for scaling float to fixed-point
+#define MAX_PLAN_LOG2 16  // Largest FFT size with cached tables (2^16), bigger FFTs compute them on the fly
+
+//Tables for one FFT size, read-only once created (see fft_get_plan)
+typedef struct
+{
+    uint32_t n;
+    uint32_t log2n;
+    uint32_t *bitrev;       //Bit-reversal permutation
+    int32_t *tw_re;         //Twiddle factors (Q16), n/2 of each
+    int32_t *tw_im;
+    float *window;          //Hamming window, same values apply_hamming_window used to compute
+} fftPlan;
+
+#ifndef DOS_HOST_BUILD
 #include "pd_api.h"
 
 void registerFFT(PlaydateAPI* playdate);
+#endif
+
+//Fixed-point radix-2 transforms (n must be a power of 2), shared with filter.c and the host tools
+int fft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n);
+int ifft_fixed_iterative(int32_t *real, int32_t *imag, uint32_t n);
+void apply_hamming_window(int32_t *real, int n);
+void remove_hamming_window(int32_t *real, int n);
+float fft_bin_scale(uint32_t idx, uint32_t n);
+
+const fftPlan* fft_get_plan(uint32_t n);
+void fft_plan_cache_free(void);
 
+// Fixed-point multiplication (Q16), rounded to the nearest so the error doesn't build up along the FFT stages
+static inline int32_t fixed_mul(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b + (1 << (FIXED_SHIFT - 1))) >> FIXED_SHIFT);
+}
 
-#endif /* samples_h */
\ No newline at end of file
+#endif /* fft_h */
@@ -0,0 +1,373 @@
+#include "samples.h"
+#include "fft.h"
+#include "filter.h"
+
+#define MAX_TAPS 1025           // Longest kernel accepted (keeps the FFT block at 4096)
+#define MIN_BLOCK_SIZE 256      // Smallest FFT block used for overlap-save
+
+static PlaydateAPI* pd = NULL;
+
+//Filter Struture and functions ------------------------------
+
+typedef struct
+{
+	int32_t *H_re;          //Frequency response of the kernel (Q16)
+    int32_t *H_im;
+    int32_t *buf_re;        //Scratch block used by the overlap-save
+    int32_t *buf_im;
+    int32_t *history;       //Last (taps-1) input samples of the previous block
+    uint32_t taps;
+    uint32_t blockSize;
+} filterData;
+
+int newBandPassFilter(lua_State* L);
+int newNotchFilter(lua_State* L);
+int free_filter(lua_State* L);
+int applyFilter(lua_State* L);
+int getTapsFilter(lua_State* L);
+int getBlockSizeFilter(lua_State* L);
+
+//Filter design
+filterData* createFilter(float *h, uint32_t taps);
+void design_lowpass(float *h, uint32_t taps, float cutoff, float SFreq, float sign);
+
+static const lua_reg filterlib[] =
+{
+	{ "newBandPass",    newBandPassFilter },
+    { "newNotch",       newNotchFilter },
+	{ "free",           free_filter },
+    { "apply",          applyFilter },
+    { "getLength",      getTapsFilter },
+    { "getBlockSize",   getBlockSizeFilter },
+	{ NULL, NULL }
+};
+//------------------------------------------------------------
+
+//Registering Functions---------------------------------------
+
+void registerFilter(PlaydateAPI* playdate){
+    pd = playdate;
+
+	const char* err;
+
+	if ( !pd->lua->registerClass("filterlib.filter",filterlib,NULL, 0, &err) )
+            pd->system->logToConsole("%s:%i: addFunction failed, %s", __FILE__, __LINE__, err);
+}
+//--------------------------------------------------------------
+
+//Filter--------------------------------------------------------
+
+/**
+* Function:     newBandPassFilter
+* Arguments:    lowFreq             -Float lower cutoff frequency (Hz)
+*               highFreq            -Float upper cutoff frequency (Hz)
+*               taps                -Int length of the FIR kernel (made odd, max 1025)
+*               SFreq               -Int sampling frequency (if <=0 uses 44100)
+*               
+* Returns:      fl                  -filterlib.filter object
+* Description:  Creates a windowed-sinc band-pass filter, e.g. 300Hz-16kHz to remove mic hum and hiss
+**/
+int newBandPassFilter(lua_State* L){
+    float lowFreq = pd->lua->getArgFloat(1);
+    float highFreq = pd->lua->getArgFloat(2);
+    int taps = pd->lua->getArgInt(3);
+    float SFreq = (float)pd->lua->getArgInt(4);
+
+    if(SFreq <= 0) SFreq = 44100;
+    if((taps < 3) || (taps > MAX_TAPS) || (lowFreq < 0) || (highFreq <= lowFreq) || (highFreq > SFreq/2)){
+        return 0;
+    }
+    if(taps % 2 == 0) taps++;
+
+    float *h = pd->system->realloc(NULL, (sizeof(float) * taps));
+    if(h == NULL){
+        return 0;
+    }
+    for(int i=0;i<taps;i++){
+        h[i] = 0;
+    }
+
+    //Band-pass = lowpass(highFreq) - lowpass(lowFreq)
+    design_lowpass(h, taps, highFreq, SFreq, 1.0f);
+    design_lowpass(h, taps, lowFreq, SFreq, -1.0f);
+
+    filterData *fl = createFilter(h, taps);
+    pd->system->realloc(h, 0);
+    if(fl == NULL){
+        return 0;
+    }
+
+    pd->lua->pushObject(fl, "filterlib.filter", 0);
+
+	return 1;
+}
+
+/**
+* Function:     newNotchFilter
+* Arguments:    centerFreq          -Float frequency to remove (Hz)
+*               bandwidth           -Float width of the removed band (Hz)
+*               taps                -Int length of the FIR kernel (made odd, max 1025)
+*               SFreq               -Int sampling frequency (if <=0 uses 44100)
+*               
+* Returns:      fl                  -filterlib.filter object
+* Description:  Creates a windowed-sinc band-stop filter around centerFreq (all-pass minus band-pass)
+**/
+int newNotchFilter(lua_State* L){
+    float centerFreq = pd->lua->getArgFloat(1);
+    float bandwidth = pd->lua->getArgFloat(2);
+    int taps = pd->lua->getArgInt(3);
+    float SFreq = (float)pd->lua->getArgInt(4);
+
+    if(SFreq <= 0) SFreq = 44100;
+    float lowFreq = centerFreq - bandwidth/2;
+    float highFreq = centerFreq + bandwidth/2;
+    if(lowFreq < 0) lowFreq = 0;
+    if((taps < 3) || (taps > MAX_TAPS) || (bandwidth <= 0) || (highFreq > SFreq/2)){
+        return 0;
+    }
+    if(taps % 2 == 0) taps++;
+
+    float *h = pd->system->realloc(NULL, (sizeof(float) * taps));
+    if(h == NULL){
+        return 0;
+    }
+    for(int i=0;i<taps;i++){
+        h[i] = 0;
+    }
+
+    //Notch = delta - (lowpass(highFreq) - lowpass(lowFreq))
+    h[(taps-1)/2] = 1.0f;
+    design_lowpass(h, taps, highFreq, SFreq, -1.0f);
+    design_lowpass(h, taps, lowFreq, SFreq, 1.0f);
+
+    filterData *fl = createFilter(h, taps);
+    pd->system->realloc(h, 0);
+    if(fl == NULL){
+        return 0;
+    }
+
+    pd->lua->pushObject(fl, "filterlib.filter", 0);
+
+	return 1;
+}
+
+/**
+* Function:     free_filter
+* Arguments:    fl                  -filterlib.filter object to free
+*               
+* Returns:
+* Description:  Frees memory
+**/
+int free_filter(lua_State* L){
+    filterData* fl = pd->lua->getArgObject(1, "filterlib.filter", NULL);
+
+    if(fl==NULL){
+        return 0;
+    }
+
+	// realloc with size 0 to free
+    pd->system->realloc(fl->H_re, 0);
+    pd->system->realloc(fl->H_im, 0);
+    pd->system->realloc(fl->buf_re, 0);
+    pd->system->realloc(fl->buf_im, 0);
+    pd->system->realloc(fl->history, 0);
+	pd->system->realloc(fl, 0);
+
+	return 0;
+}
+
+/**
+* Function:     applyFilter
+* Arguments:    fl                  -filterlib.filter object to use
+*               s                   -samplelib.samples to filter (in place)
+*               startIdx            -Int starting index to filter
+*               endIdx              -Int end index to filter
+*               
+* Returns:
+* Description:  Filters the samples between startIdx and endIdx block by block using overlap-save fast convolution
+*               The (taps-1)/2 samples of kernel delay are compensated, so tones stay at the same sample index
+**/
+int applyFilter(lua_State* L){
+    filterData* fl = pd->lua->getArgObject(1, "filterlib.filter", NULL);
+    Samples* s = pd->lua->getArgObject(2, "samplelib.samples", NULL);
+    int startIdx = pd->lua->getArgInt(3);
+    int endIdx = pd->lua->getArgInt(4);
+
+    if((fl == NULL) || (s == NULL) || (s->data == NULL)){
+        return 0;
+    }
+    if(s->file != NULL){
+        pd->system->logToConsole("%s:%i: apply can't write to a samplelib.samples streamed from a file", __FILE__, __LINE__);
+        return 0;
+    }
+
+    if((startIdx > (int)s->length) || (startIdx < 0)) startIdx = 0;
+    if((endIdx > (int)s->length) || (endIdx < 0)) endIdx = (int)s->length;
+
+    int n = fl->blockSize;
+    int overlap = fl->taps - 1;         //Samples from the previous block needed by each output
+    int step = n - overlap;             //New samples consumed per block
+    int delay = overlap/2;              //Group delay of the linear phase kernel
+
+    //Samples before startIdx are still unfiltered, so use them as the first history
+    for(int i=0;i<overlap;i++){
+        int idx = startIdx - overlap + i;
+        fl->history[i] = (idx >= 0) ? s->data[idx] : 0;
+    }
+
+    //Keep going past endIdx until the delayed outputs reach it
+    for(int pos=startIdx; pos-delay < endIdx; pos+=step){
+        int i=0;
+
+        for(i=0;i<overlap;i++){
+            fl->buf_re[i] = fl->history[i];
+        }
+        for(i=0;i<step;i++){
+            int idx = pos + i;
+            fl->buf_re[overlap+i] = (idx < (int)s->length) ? s->data[idx] : 0;
+        }
+        for(i=0;i<n;i++){
+            fl->buf_im[i] = 0;
+        }
+
+        //The outputs are written behind pos, so the next history must be saved before they overwrite anything
+        for(i=0;i<overlap;i++){
+            fl->history[i] = fl->buf_re[step+i];
+        }
+
+        fft_fixed_iterative(fl->buf_re, fl->buf_im, n);
+        for(i=0;i<n;i++){
+            int32_t re = fixed_mul(fl->buf_re[i], fl->H_re[i]) - fixed_mul(fl->buf_im[i], fl->H_im[i]);
+            int32_t im = fixed_mul(fl->buf_re[i], fl->H_im[i]) + fixed_mul(fl->buf_im[i], fl->H_re[i]);
+            fl->buf_re[i] = re;
+            fl->buf_im[i] = im;
+        }
+        ifft_fixed_iterative(fl->buf_re, fl->buf_im, n);
+
+        //The first "overlap" outputs are wrapped around by the circular convolution and are discarded
+        for(i=0;i<step;i++){
+            int idx = pos + i - delay;
+            if(idx < startIdx) continue;
+            if(idx >= endIdx) break;
+
+            int32_t val = fl->buf_re[overlap+i];
+            if(val > 32767) val = 32767;
+            if(val < -32768) val = -32768;
+            s->data[idx] = (short int)val;
+        }
+    }
+
+	return 0;
+}
+
+/**
+* Function:     getTapsFilter
+* Arguments:    fl                  -filterlib.filter object to analyse
+*               
+* Returns:      fl->taps            -Int length of the FIR kernel
+* Description:  Gets the number of taps of the filter
+**/
+int getTapsFilter(lua_State* L){
+    filterData* fl = pd->lua->getArgObject(1, "filterlib.filter", NULL);
+    if(fl == NULL){
+        pd->lua->pushInt(-1);
+        return 1;
+    }
+
+    pd->lua->pushInt((int)fl->taps);
+
+	return 1;
+}
+
+/**
+* Function:     getBlockSizeFilter
+* Arguments:    fl                  -filterlib.filter object to analyse
+*               
+* Returns:      fl->blockSize       -Int size of the FFT used for each block
+* Description:  Gets the FFT block size of the filter
+**/
+int getBlockSizeFilter(lua_State* L){
+    filterData* fl = pd->lua->getArgObject(1, "filterlib.filter", NULL);
+    if(fl == NULL){
+        pd->lua->pushInt(-1);
+        return 1;
+    }
+
+    pd->lua->pushInt((int)fl->blockSize);
+
+	return 1;
+}
+
+
+//Filter design----------------------------
+/**
+* Function:     design_lowpass
+* Arguments:    *h                  -float pointer to the kernel to add to
+*               taps                -int number of elements in the kernel (odd)
+*               cutoff              -float cutoff frequency (Hz)
+*               SFreq               -float sampling frequency
+*               sign                -float 1 to add the lowpass to h, -1 to subtract it
+*               
+* Returns:
+* Description:  Adds a hamming windowed-sinc lowpass kernel to h
+**/
+void design_lowpass(float *h, uint32_t taps, float cutoff, float SFreq, float sign){
+    float fc = cutoff/SFreq;
+    int mid = (taps-1)/2;
+
+    for(int i=0;i<(int)taps;i++){
+        int m = i - mid;
+        float val = 2*fc;
+        if(m != 0){
+            val = sinf(2*PI*fc*m)/(PI*m);
+        }
+        val *= 0.54f - 0.46f * cosf(2 * PI * i / (taps - 1));
+        h[i] += sign*val;
+    }
+}
+
+/**
+* Function:     createFilter
+* Arguments:    *h                  -float pointer to the kernel
+*               taps                -int number of elements in the kernel
+*               
+* Returns:      fl                  -filterData with the kernel's frequency response and scratch buffers
+* Description:  Picks the FFT block size (power of 2, about 4 times the kernel) and precomputes the kernel's FFT
+**/
+filterData* createFilter(float *h, uint32_t taps){
+    uint32_t n = MIN_BLOCK_SIZE;
+    while(n < 4*(taps-1)){
+        n = n<<1;
+    }
+
+    filterData *fl = pd->system->realloc(NULL, (sizeof(filterData)));
+    if(fl == NULL){
+        return NULL;
+    }
+    fl->taps = taps;
+    fl->blockSize = n;
+    fl->H_re = pd->system->realloc(NULL, (sizeof(int32_t) * n));
+    fl->H_im = pd->system->realloc(NULL, (sizeof(int32_t) * n));
+    fl->buf_re = pd->system->realloc(NULL, (sizeof(int32_t) * n));
+    fl->buf_im = pd->system->realloc(NULL, (sizeof(int32_t) * n));
+    fl->history = pd->system->realloc(NULL, (sizeof(int32_t) * taps));
+
+    if((fl->H_re == NULL) || (fl->H_im == NULL) || (fl->buf_re == NULL) || (fl->buf_im == NULL) || (fl->history == NULL)){
+        pd->system->realloc(fl->H_re, 0);
+        pd->system->realloc(fl->H_im, 0);
+        pd->system->realloc(fl->buf_re, 0);
+        pd->system->realloc(fl->buf_im, 0);
+        pd->system->realloc(fl->history, 0);
+        pd->system->realloc(fl, 0);
+        return NULL;
+    }
+
+    //Zero padded kernel in Q16, so multiplying by H keeps the samples' scale
+    for(uint32_t i=0;i<n;i++){
+        fl->H_re[i] = (i < taps) ? (int32_t)(h[i] * FIXED_SCALE) : 0;
+        fl->H_im[i] = 0;
+    }
+    fft_fixed_iterative(fl->H_re, fl->H_im, n);
+
+    return fl;
+}
@@ -0,0 +1,11 @@
+#ifndef filter_h
+#define filter_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pd_api.h"
+
+void registerFilter(PlaydateAPI* playdate);
+
+#endif /* filter_h */
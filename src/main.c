@@ -3,6 +3,7 @@
 #define TARGET_EXTENSION 1
 
 #include "fft.h"
+#include "filter.h"
 #include "pd_api.h"
 
 static PlaydateAPI* pd = NULL;
@@ -13,6 +14,12 @@ int eventHandler(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg) {
 		pd = playdate;
         
 	    registerFFT(pd);
+	    registerFilter(pd);
+    }
+    else if ( event == kEventTerminate )
+    {
+        //The FFT tables stay cached between FFTs, give them back to the heap
+        fft_plan_cache_free();
     }
     return 0;
 }
@@ -1,9 +1,12 @@
+#include <string.h>
 #include "samples.h"
 
+#ifndef DOS_HOST_BUILD
 static PlaydateAPI* pd = NULL;
 
 //Samples Struture and functions ---------------------------------
 int extract_samples(lua_State* L);
+int stream_samples(lua_State* L);
 int free_samples(lua_State* L);
 int syntheticDataCreator(lua_State* L);
 int getSample(lua_State* L);
@@ -11,9 +14,14 @@ int getNumSample(lua_State* L);
 int getSampleFreq(lua_State* L);
 int getSigEnergy(lua_State* L);
 
+//Streaming
+int readWavHeader(Samples* s);
+int loadChunk(Samples* s, uint32_t start);
+
 static const lua_reg samplelib[] =
 {
 	{ "new",            extract_samples},
+    { "newFromFile",    stream_samples},
 	{ "free",           free_samples },
     { "syntheticData",  syntheticDataCreator},
 	{ "getSample",      getSample },
@@ -58,6 +66,13 @@ int extract_samples(lua_State* L) {
 
     s->length = (uint32_t) (s->length/2);
 
+    // The whole recording is in memory, so it is a single chunk
+    s->file = NULL;
+    s->dataOffset = 0;
+    s->chunkSize = s->length;
+    s->chunkStart = 0;
+    s->chunkLength = s->length;
+
     if (s->data == NULL) {
         pd->lua->pushString("Failed to retrieve sample data");
         return 1;
@@ -71,16 +86,78 @@ int extract_samples(lua_State* L) {
 
 }
 
+/**
+* Function:     stream_samples
+* Arguments:    path                    -String path of a 16 bit mono .wav file (e.g. saved with playdate.sound.sample:save)
+*               chunkSize               -Int samples kept in memory at a time (if <=STREAM_OVERLAP uses STREAM_CHUNK_SIZE)
+*               
+* Returns:      s                       -samplelib.samples that we want to create
+* Description:  Creates a samplelib.samples object that reads the recording from the file in chunks instead of keeping it all in memory
+*               The fftlib.fft and energy functions work the same on it, but syntheticData can't write to it
+**/
+int stream_samples(lua_State* L) {
+    const char* path = pd->lua->getArgString(1);
+    int chunkSize = pd->lua->getArgInt(2);
+
+    if(path == NULL){
+        return 0;
+    }
+    if(chunkSize <= STREAM_OVERLAP) chunkSize = STREAM_CHUNK_SIZE;
+
+    Samples *s = pd->system->realloc(NULL, (sizeof(Samples)));
+    if(s == NULL){
+        return 0;
+    }
+    s->data = NULL;
+    s->file = pd->file->open(path, kFileRead|kFileReadData);
+    if(s->file == NULL){
+        pd->system->logToConsole("%s:%i: couldn't open %s, %s", __FILE__, __LINE__, path, pd->file->geterr());
+        pd->system->realloc(s, 0);
+        return 0;
+    }
+
+    if(!readWavHeader(s)){
+        pd->system->logToConsole("%s:%i: %s is not a 16 bit mono .wav file", __FILE__, __LINE__, path);
+        pd->file->close(s->file);
+        pd->system->realloc(s, 0);
+        return 0;
+    }
+
+    s->chunkSize = (uint32_t)chunkSize;
+    s->chunkStart = 0;
+    s->chunkLength = 0;
+    s->data = pd->system->realloc(NULL, (sizeof(short int) * s->chunkSize));
+    if(s->data == NULL){
+        pd->file->close(s->file);
+        pd->system->realloc(s, 0);
+        return 0;
+    }
+
+    pd->lua->pushObject(s, "samplelib.samples", 0);
+
+    return 1;
+}
+
 /**
 * Function:     free_samples
 * Arguments:    s                  -samplelib.samples to free
 *               
 * Returns:
-* Description:  Frees memory
+* Description:  Frees memory (and closes the file when streaming)
 **/
 int free_samples(lua_State* L){
     Samples* s = pd->lua->getArgObject(1, "samplelib.samples", NULL);
-    
+
+    if(s == NULL){
+        return 0;
+    }
+
+    // Only the streaming chunk buffer is ours, otherwise data belongs to the playdate.sound.sample
+    if(s->file != NULL){
+        pd->file->close(s->file);
+        pd->system->realloc(s->data, 0);
+    }
+
 	// realloc with size 0 to free
 	pd->system->realloc(s, 0);
 
@@ -111,6 +188,10 @@ int syntheticDataCreator(lua_State* L){
     if((s == NULL) || (s->data == NULL)){
         return 0;
     }
+    if(s->file != NULL){
+        pd->system->logToConsole("%s:%i: syntheticData can't write to a samplelib.samples streamed from a file", __FILE__, __LINE__);
+        return 0;
+    }
     if(startIdx > (int)s->length || startIdx < 0) startIdx = 0;
     if(endIdx > (int)s->length || endIdx < 0) endIdx = (int)s->length;
     
@@ -147,12 +228,14 @@ int getSample(lua_State* L){
         return 1;
     }
 
-    if(sampleN > (int)s->length || sampleN < 0){
+    int available = 0;
+    const short int* data = getSampleChunk(s, sampleN, sampleN+1, &available);
+    if(data == NULL){
         pd->lua->pushInt(0);
 	    return 1;
     }
 
-    pd->lua->pushInt((int) s->data[sampleN]);
+    pd->lua->pushInt((int) data[0]);
 
 	return 1;
 }
@@ -217,20 +300,171 @@ int getSigEnergy(lua_State* L){
     if(startIdx > (int)s->length || startIdx < 0) startIdx = 0;
     if(endIdx > (int)s->length || endIdx < 0) endIdx = (int)s->length;
 
+    pd->lua->pushFloat(signalEnergy(s, startIdx, endIdx));
+
+	return 1;
+}
+
+//Streaming----------------------------------------------------
+static uint32_t read_u32(const uint8_t *p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+* Function:     readWavHeader
+* Arguments:    s                   -samplelib.samples with the file open
+*               
+* Returns:      1 if it found 16 bit mono PCM data, 0 otherwise
+* Description:  Walks the .wav chunks and fills in the sampling frequency, length and dataOffset of s
+**/
+int readWavHeader(Samples* s){
+    uint8_t header[16];
+    int haveFmt = 0;
+    uint32_t offset = 12;
+
+    if(pd->file->read(s->file, header, 12) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header+8, "WAVE", 4) != 0){
+        return 0;
+    }
+
+    while(pd->file->read(s->file, header, 8) == 8){
+        uint32_t size = read_u32(header+4);
+        offset += 8;
+
+        if(memcmp(header, "fmt ", 4) == 0){
+            if(size < 16 || pd->file->read(s->file, header, 16) != 16){
+                return 0;
+            }
+            //PCM, 1 channel, 16 bits
+            if((header[0] | (header[1] << 8)) != 1 || (header[2] | (header[3] << 8)) != 1 || (header[14] | (header[15] << 8)) != 16){
+                return 0;
+            }
+            s->SFormat = kSound16bitMono;
+            s->SFreq = read_u32(header+4);
+            haveFmt = 1;
+        }else if(memcmp(header, "data", 4) == 0){
+            if(!haveFmt){
+                return 0;
+            }
+            s->dataOffset = offset;
+            s->length = size/2;
+            return 1;
+        }
+
+        //Chunks are padded to an even size
+        offset += size + (size & 1);
+        pd->file->seek(s->file, (int)offset, SEEK_SET);
+    }
+
+    return 0;
+}
+
+/**
+* Function:     loadChunk
+* Arguments:    s                   -samplelib.samples streaming from a file
+*               start               -Index of the first sample to load
+*               
+* Returns:      Number of samples loaded
+* Description:  Reads up to s->chunkSize samples starting at start into s->data
+**/
+int loadChunk(Samples* s, uint32_t start){
+    uint32_t n = s->chunkSize;
+    if(start + n > s->length) n = s->length - start;
+
+    s->chunkStart = start;
+    s->chunkLength = 0;
+
+    if(pd->file->seek(s->file, (int)(s->dataOffset + start*sizeof(short int)), SEEK_SET) != 0){
+        return 0;
+    }
+    int bytes = pd->file->read(s->file, s->data, n*sizeof(short int));
+    if(bytes > 0){
+        s->chunkLength = (uint32_t)bytes/sizeof(short int);
+    }
+
+    return (int)s->chunkLength;
+}
+#endif /* DOS_HOST_BUILD */
+
+/**
+* Function:     getSampleChunk
+* Arguments:    s                   -samplelib.samples to read
+*               idx                 -Int index of the first sample needed
+*               endIdx              -Int index after the last sample needed (used to avoid straddling two chunks)
+*               *available          -Int number of samples that can be read from the returned pointer
+*               
+* Returns:      Pointer to sample idx, NULL if idx is out of range or the file couldn't be read
+* Description:  Gives access to the samples whether they are all in memory or streamed from a file
+*               When streaming, chunks start at multiples of (chunkSize - STREAM_OVERLAP), so a window of up to
+*               STREAM_OVERLAP samples always fits in one chunk and scanning forward reads each chunk once
+*               Callers loop until they got all the samples they need, for(i...){ p = getSampleChunk(s,i,end,&n); ... i+=n; }
+**/
+const short int* getSampleChunk(Samples* s, int idx, int endIdx, int* available){
+    if((s == NULL) || (s->data == NULL) || (idx < 0) || (idx >= (int)s->length)){
+        return NULL;
+    }
+
+    if(s->file == NULL){
+        *available = (int)s->length - idx;
+        return s->data + idx;
+    }
+
+#ifndef DOS_HOST_BUILD
+    int want = endIdx - idx;
+    if(want > (int)s->length - idx) want = (int)s->length - idx;
+    if(want > STREAM_OVERLAP) want = STREAM_OVERLAP;
+    if(want < 1) want = 1;
+
+    if((idx < (int)s->chunkStart) || (idx + want > (int)(s->chunkStart + s->chunkLength))){
+        uint32_t step = s->chunkSize - STREAM_OVERLAP;
+        int loaded = loadChunk(s, (idx/step)*step);
+        if(loaded <= idx - (int)s->chunkStart){
+            return NULL;
+        }
+    }
+
+    *available = (int)(s->chunkStart + s->chunkLength) - idx;
+    return s->data + (idx - s->chunkStart);
+#else
+    (void)endIdx;
+    return NULL;
+#endif
+}
+
+/**
+* Function:     signalEnergy
+* Arguments:    s                   -samplelib.samples to analyse
+*               startIdx            -Int Index to start analysing
+*               endIdx              -Int Index to end the analysis
+*               
+* Returns:      Energy              -Float represent the energy of the signal
+* Description:  Variance of the samples between the start index and end index (shared by getSigEnergy and the host tools)
+**/
+float signalEnergy(Samples* s, int startIdx, int endIdx){
     float Energy = 0;
     float mean = 0;
+    const short int* data;
+    int available = 0;
+    int i = 0, k = 0;
 
-    for(int i=startIdx;i<endIdx;i++){
-        mean+=s->data[i];
+    if(endIdx <= startIdx){
+        return 0;
+    }
+
+    for(i=startIdx;i<endIdx;){
+        if((data = getSampleChunk(s, i, endIdx, &available)) == NULL) break;
+        for(k=0;k<available && i<endIdx;k++,i++){
+            mean+=data[k];
+        }
     }
     mean/=(endIdx-startIdx);
 
-    for(int i=startIdx;i<endIdx;i++){
-        Energy+=powf((s->data[i]-mean),2);
+    for(i=startIdx;i<endIdx;){
+        if((data = getSampleChunk(s, i, endIdx, &available)) == NULL) break;
+        for(k=0;k<available && i<endIdx;k++,i++){
+            Energy+=powf((data[k]-mean),2);
+        }
     }
     Energy/=(endIdx-startIdx);
 
-    pd->lua->pushFloat(Energy);
-
-	return 1;
+    return Energy;
 }
\ No newline at end of file
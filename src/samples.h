@@ -4,19 +4,49 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdint.h>
 
+#ifndef DOS_HOST_BUILD
 #define TARGET_EXTENSION 1
 
 #include "pd_api.h"
+#else
+//Same values as the Playdate SDK, so host tools can fill in a Samples object
+typedef enum
+{
+	kSound8bitMono = 0,
+	kSound8bitStereo = 1,
+	kSound16bitMono = 2,
+	kSound16bitStereo = 3
+} SoundFormat;
+
+//Host tools only use in-memory samples
+typedef void SDFile;
+#endif
+
+#define STREAM_CHUNK_SIZE 8192      // Default samples per chunk when streaming from a file (16KB)
+#define STREAM_OVERLAP 512          // Samples shared by consecutive chunks, windows up to this size never straddle two chunks
 
 typedef struct
 {
-	short int *data;
+	short int *data;            //Whole recording, or the chunk currently loaded when streaming
     SoundFormat SFormat;
     uint32_t SFreq;
-    uint32_t length;
+    uint32_t length;            //Number of samples in the whole recording
+
+    //Streaming from a file (file == NULL means data holds the whole recording)
+    SDFile *file;
+    uint32_t dataOffset;        //Byte offset of the first sample in the file
+    uint32_t chunkSize;         //Capacity of data, in samples
+    uint32_t chunkStart;        //Index of data[0] in the recording
+    uint32_t chunkLength;       //Number of samples loaded in data
 } Samples;
 
+#ifndef DOS_HOST_BUILD
 void registerSamples(PlaydateAPI* playdate);
+#endif
+
+const short int* getSampleChunk(Samples* s, int idx, int endIdx, int* available);
+float signalEnergy(Samples* s, int startIdx, int endIdx);
 
-#endif /* samples_h */
\ No newline at end of file
+#endif /* samples_h */